@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""
+Lighting benchmark
+
+Generates a synthetic bsp (a room with a sky ceiling, a pillar and a fixed
+set of lights), lights it with -stats and prints the main figures.  The map
+and the light positions are the same on every run, so results of different
+builds can be compared.
+
+usage: bench.py [--keep NAME] light.exe [light options]
+       bench.py --styles light.exe [light options]
+
+Default options are "-threads 4 -extra4".  With --keep, the .stats.json of
+the run is saved as results/NAME.json, and all saved results are listed
+next to it.
+
+--styles is a regression check for faster sampling modes: the map is lit
+with -extra4 and with the given options (default "-threads 4 -adaptive"),
+and the light styles of each face must be the same in both.
+
+The map is regenerated for every run since light writes into it.
+"""
+
+import json, os, random, shutil, struct, subprocess, sys
+
+HERE = os.path.dirname (os.path.abspath (__file__))
+BSPNAME = "bench.bsp"
+
+TILES = 8	# Faces per wall side
+NUMLIGHTS = 200	# Random lights besides the fixed ones
+SEED = 1
+
+ROOM = 128	# Half size of the room
+PILLAR = 16	# Half size of the pillar
+
+def WriteBench (path):
+	R, P = ROOM, PILLAR
+
+	# normal, dist, type
+	planes = [((1, 0, 0), -R, 0), ((1, 0, 0), R, 0), ((0, 1, 0), -R, 1), ((0, 1, 0), R, 1), ((0, 0, 1), -R, 2), ((0, 0, 1), R, 2),
+		  ((1, 0, 0), -P, 0), ((1, 0, 0), P, 0), ((0, 1, 0), -P, 1), ((0, 1, 0), P, 1), ((0, 0, 1), 0, 2)]
+
+	# Leaf 0 is solid, 1 is sky above the room, 2 the room
+	def Leaf (n):
+		return -(n + 1)
+
+	nodes = [(0, 1, Leaf (0)), (1, Leaf (0), 2), (2, 3, Leaf (0)), (3, Leaf (0), 4), (4, 5, Leaf (0)), (5, Leaf (1), 6),
+		 (6, 7, Leaf (2)), (7, Leaf (2), 8), (8, 9, Leaf (2)), (9, Leaf (2), 10), (10, Leaf (2), Leaf (0))]
+
+	# s vector, t vector, miptex, flags
+	texinfos = [((1, 0, 0, 0), (0, -1, 0, 0), 0, 0), ((0, 1, 0, 0), (0, 0, -1, 0), 0, 0),
+		    ((1, 0, 0, 0), (0, 0, -1, 0), 0, 0), ((1, 0, 0, 0), (0, -1, 0, 0), 1, 1)]
+
+	verts, edges, surfedges, faces = [], [(0, 0)], [], []
+
+	def Tiled (plane, side, tex, axis, c, a0, a1, b0, b1):
+		other = [i for i in range (3) if i != axis]
+
+		for i in range (TILES):
+			for j in range (TILES):
+				u0, u1 = a0 + (a1 - a0) * i / TILES, a0 + (a1 - a0) * (i + 1) / TILES
+				v0, v1 = b0 + (b1 - b0) * j / TILES, b0 + (b1 - b0) * (j + 1) / TILES
+				firstedge, base = len (surfedges), len (verts)
+
+				for (u, v) in ((u0, v0), (u1, v0), (u1, v1), (u0, v1)):
+					p = [0, 0, 0]
+					p[axis], p[other[0]], p[other[1]] = c, u, v
+					verts.append (tuple (p))
+
+				for k in range (4):
+					edges.append ((base + k, base + (k + 1) % 4))
+					surfedges.append (len (edges) - 1)
+
+				faces.append ((plane, side, firstedge, 4, tex))
+
+	Tiled (0, 0, 1, 0, -R, -R, R, -R, R)
+	Tiled (1, 1, 1, 0, R, -R, R, -R, R)
+	Tiled (2, 0, 2, 1, -R, -R, R, -R, R)
+	Tiled (3, 1, 2, 1, R, -R, R, -R, R)
+	Tiled (4, 0, 0, 2, -R, -R, R, -R, R)
+	Tiled (5, 1, 3, 2, R, -R, R, -R, R)	# Sky
+	Tiled (6, 1, 1, 0, -P, -P, P, -R, 0)	# Pillar
+	Tiled (7, 0, 1, 0, P, -P, P, -R, 0)
+	Tiled (8, 1, 2, 1, -P, -P, P, -R, 0)
+	Tiled (9, 0, 2, 1, P, -P, P, -R, 0)
+	Tiled (10, 0, 0, 2, 0, -P, P, -P, P)
+
+	leafcontents = [-2, -6, -1]	# CONTENTS_SOLID, CONTENTS_SKY, CONTENTS_EMPTY
+
+	ents = '{\n"classname" "worldspawn"\n"_sunlight" "150"\n"_sunlight2" "40"\n"_sun_mangle" "30 -60 0"\n}\n'
+	ents += '{\n"classname" "light"\n"origin" "-80 -80 60"\n"light" "300"\n}\n'
+	ents += '{\n"classname" "light"\n"origin" "80 60 -60"\n"light" "250"\n"delay" "1"\n"_color" "255 128 0"\n}\n'
+	ents += '{\n"classname" "light"\n"origin" "60 -90 -100"\n"light" "200"\n"style" "5"\n}\n'
+	ents += '{\n"classname" "light"\n"origin" "0 80 100"\n"light" "400"\n"mangle" "0 -90 0"\n"angle" "60"\n}\n'
+	ents += '{\n"classname" "light"\n"origin" "-90 90 -110"\n"light" "-100"\n}\n'
+
+	rnd = random.Random (SEED)
+
+	for i in range (NUMLIGHTS):
+		o = [rnd.uniform (-120, 120) for j in range (3)]
+		ents += '{\n"classname" "light"\n"origin" "%d %d %d"\n"light" "%d"\n"delay" "%d"\n}\n' % (o[0], o[1], o[2], rnd.randint (5, 40), rnd.choice ([0, 0, 0, 1, 2, 5]))
+
+	lumps = [b""] * 15
+	lumps[0] = ents.encode () + b"\0"
+	lumps[1] = b"".join (struct.pack ("<4fi", *n, d, t) for (n, d, t) in planes)
+	lumps[2] = struct.pack ("<3i", 2, 12, 52) + b"".join (struct.pack ("<16s6I", name, 16, 16, 0, 0, 0, 0) for name in (b"wall", b"sky1"))
+	lumps[3] = b"".join (struct.pack ("<3f", *v) for v in verts)
+	lumps[5] = b"".join (struct.pack ("<i8h", p, c0, c1, -R, -R, -R, R, R, R) + struct.pack ("<2H", 0, 0) for (p, c0, c1) in nodes)
+	lumps[6] = b"".join (struct.pack ("<8f2i", *s, *t, m, f) for (s, t, m, f) in texinfos)
+	lumps[7] = b"".join (struct.pack ("<2hi2h4Bi", p, side, fe, ne, tex, 0, 0, 0, 0, -1) for (p, side, fe, ne, tex) in faces)
+	lumps[10] = b"".join (struct.pack ("<2i6h2H4B", c, -1, -R, -R, -R, R, R, R, 0, len (faces) if i == 2 else 0, 0, 0, 0, 0) for i, c in enumerate (leafcontents))
+	lumps[11] = b"".join (struct.pack ("<H", f) for f in range (len (faces)))
+	lumps[12] = b"".join (struct.pack ("<2H", *e) for e in edges)
+	lumps[13] = b"".join (struct.pack ("<i", e) for e in surfedges)
+	lumps[14] = struct.pack ("<9f7i", -R, -R, -R, R, R, R, 0, 0, 0, 0, 0, 0, 0, 1, 0, len (faces))
+
+	header, body = struct.pack ("<i", 29), b""	# BSPVERSION
+
+	for lump in lumps:
+		header += struct.pack ("<2i", 4 + 15 * 8 + len (body), len (lump))
+		body += lump + b"\0" * (-len (lump) % 4)
+
+	with open (path, "wb") as f:
+		f.write (header + body)
+
+	return len (faces)
+
+def FaceStyles (path):
+	with open (path, "rb") as f:
+		data = f.read ()
+
+	ofs, size = struct.unpack_from ("<2i", data, 4 + 7 * 8)	# LUMP_FACES
+
+	return [struct.unpack_from ("<4B", data, ofs + i + 12) for i in range (0, size, 20)]
+
+def CheckStyles (light, options):
+	workdir = os.path.join (HERE, "work")
+	os.makedirs (workdir, exist_ok = True)
+	path = os.path.join (workdir, BSPNAME)
+	runs = []
+
+	for opts in (["-threads", "4", "-extra4"], options):
+		WriteBench (path)
+		subprocess.run ([light] + opts + [BSPNAME], cwd = workdir, stdout = subprocess.DEVNULL, check = True)
+		runs.append (FaceStyles (path))
+
+	bad = 0
+
+	for i, (ref, styles) in enumerate (zip (*runs)):
+		if ref != styles:
+			print ("face %d: styles %s with -extra4, %s with %s" % (i, ref, styles, " ".join (options)))
+			bad += 1
+
+	print ("%d of %d faces with different styles" % (bad, len (runs[0])))
+
+	return bad == 0
+
+def PrintResult (name, stats):
+	print ("%-16s %9.3f %9.3f %12.0f %8.2f" % (name, stats["walltime"], stats["facetime"], stats["rays"], stats["nodesperray"]))
+
+def main ():
+	args = sys.argv[1:]
+	keep = None
+
+	if len (args) >= 2 and args[0] == "--keep":
+		keep = args[1]
+		args = args[2:]
+
+	if len (args) >= 2 and args[0] == "--styles":
+		ok = CheckStyles (os.path.abspath (args[1]), args[2:] or ["-threads", "4", "-adaptive"])
+		sys.exit (0 if ok else 1)
+
+	if not args:
+		sys.exit (__doc__)
+
+	light = os.path.abspath (args[0])
+	options = args[1:] or ["-threads", "4", "-extra4"]
+
+	workdir = os.path.join (HERE, "work")
+	os.makedirs (workdir, exist_ok = True)
+
+	numfaces = WriteBench (os.path.join (workdir, BSPNAME))
+	print ("%s: %d faces, %d lights, options %s" % (BSPNAME, numfaces, NUMLIGHTS + 5, " ".join (options)))
+
+	subprocess.run ([light, "-stats"] + options + [BSPNAME], cwd = workdir, stdout = subprocess.DEVNULL, check = True)
+
+	statsname = os.path.join (workdir, "bench.stats.json")
+
+	with open (statsname) as f:
+		stats = json.load (f)
+
+	print ("%-16s %9s %9s %12s %8s" % ("", "walltime", "facetime", "rays", "nodes/ray"))
+	PrintResult ("this run", stats)
+
+	if keep:
+		resultdir = os.path.join (HERE, "results")
+		os.makedirs (resultdir, exist_ok = True)
+		shutil.copy (statsname, os.path.join (resultdir, keep + ".json"))
+
+		for name in sorted (os.listdir (resultdir)):
+			if name.endswith (".json"):
+				with open (os.path.join (resultdir, name)) as f:
+					PrintResult (name[:-5], json.load (f))
+
+if __name__ == "__main__":
+	main ()